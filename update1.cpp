@@ -7,7 +7,41 @@
 #include <queue>
 #include <sstream>
 #include <cmath>
+#include <climits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <atomic>
+#include <filesystem>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <list>
+#include <random>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2_DISPATCH 1
+#include <immintrin.h>
+#endif
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET socket_t;
+#define closeSocket closesocket
+#define MSG_NOSIGNAL 0
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <unistd.h>
+typedef int socket_t;
+#define INVALID_SOCKET (-1)
+#define closeSocket close
+#endif
 using namespace std;
+namespace fs = std::filesystem;
 
 // Cấu trúc tiến trình
 struct Process {
@@ -29,27 +63,49 @@ struct Process {
           remainingBurst(b), queueLevel(0), lastRunTime(a) {}
 };
 
-vector<Process> readProcesses(const string& filename) {
-    vector<Process> processes;
-    ifstream file(filename);    
-    if (!file.is_open()) {
-        cout << "Khong the mo file: " << filename << endl;
-        return processes;
-    }
+// Đọc danh sách tiến trình từ một luồng bất kỳ (file, chuỗi...), không in gì ra màn hình.
+// Trả về false và mô tả lỗi trong error nếu có dòng không đúng định dạng "PID Arrival Burst [Priority]".
+bool parseProcesses(istream& in, vector<Process>& processes, string& error) {
+    processes.clear();
     string line;
-    while (getline(file, line)) {
+    int lineNumber = 0;
+    while (getline(in, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
         if (line.empty() || line[0] == '#') continue;    
         stringstream ss(line);
         string id;
         int arrival, burst, priority = 0;
         
-        ss >> id >> arrival >> burst;
+        if (!(ss >> id)) continue;    // Dòng chỉ có khoảng trắng
+        if (!(ss >> arrival >> burst) || arrival < 0 || burst < 0) {
+            error = "Dong " + to_string(lineNumber) + " khong hop le: " + line;
+            return false;
+        }
         if (ss >> priority) {
             processes.push_back(Process(id, arrival, burst, priority));
+        } else if (!ss.eof()) {
+            error = "Priority khong hop le o dong " + to_string(lineNumber) + ": " + line;
+            return false;
         } else {
             processes.push_back(Process(id, arrival, burst, 0));
         }
     }
+    return true;
+}
+
+vector<Process> readProcesses(const string& filename) {
+    ifstream file(filename);    
+    if (!file.is_open()) {
+        cout << "Khong the mo file: " << filename << endl;
+        return {};
+    }
+    vector<Process> processes;
+    string error;
+    if (!parseProcesses(file, processes, error)) {
+        cout << error << endl;
+        return {};
+    }
     
     file.close();
     cout << "Da doc " << processes.size() << " tien trinh tu file.\n" << endl;
@@ -57,7 +113,108 @@ vector<Process> readProcesses(const string& filename) {
 }
 
 
-pair<double, double> calculateAverages(const vector<Process>& processes) {
+// Trên ngưỡng này, FCFS dùng quét tiền tố song song và các phép rút gọn dùng SIMD
+const size_t PARALLEL_THRESHOLD = 1 << 20;
+
+// Tổng/min/max của waiting và turnaround. Tổng cộng dồn bằng số nguyên 64-bit nên
+// kết quả không phụ thuộc thứ tự cộng.
+struct MetricSummary {
+    long long totalWaiting = 0, totalTurnaround = 0;
+    int minWaiting = INT_MAX, maxWaiting = INT_MIN;
+    int minTurnaround = INT_MAX, maxTurnaround = INT_MIN;
+};
+
+MetricSummary summarizeMetricsScalar(const Process* p, size_t n) {
+    MetricSummary m;
+    for (size_t i = 0; i < n; i++) {
+        m.totalWaiting += p[i].waiting;
+        m.totalTurnaround += p[i].turnaround;
+        m.minWaiting = min(m.minWaiting, p[i].waiting);
+        m.maxWaiting = max(m.maxWaiting, p[i].waiting);
+        m.minTurnaround = min(m.minTurnaround, p[i].turnaround);
+        m.maxTurnaround = max(m.maxTurnaround, p[i].turnaround);
+    }
+    return m;
+}
+
+#ifdef HAVE_AVX2_DISPATCH
+// Các hàm AVX2 được biên dịch riêng với target("avx2") và chỉ được gọi khi CPU hỗ trợ,
+// nên bản build mặc định (không có -mavx2) vẫn dùng được đường SIMD
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+bool cpuHasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+// Cộng 8 số int32 (mở rộng lên int64) vào bộ tích lũy
+AVX2_TARGET static inline __m256i addWidened(__m256i acc, __m256i v) {
+    acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+    return _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+}
+
+AVX2_TARGET static inline long long horizontalSum64(__m256i v) {
+    alignas(32) long long lanes[4];
+    _mm256_store_si256((__m256i*)lanes, v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+AVX2_TARGET static inline int horizontalMin32(__m256i v) {
+    alignas(32) int lanes[8];
+    _mm256_store_si256((__m256i*)lanes, v);
+    return *min_element(lanes, lanes + 8);
+}
+
+AVX2_TARGET static inline int horizontalMax32(__m256i v) {
+    alignas(32) int lanes[8];
+    _mm256_store_si256((__m256i*)lanes, v);
+    return *max_element(lanes, lanes + 8);
+}
+
+// Process là mảng cấu trúc (AoS), nên gom 8 trường waiting/turnaround liên tiếp bằng gather.
+// Mỗi Process chiếm hơn một nửa dòng cache nên vòng lặp bị giới hạn bởi băng thông bộ nhớ như bản
+// vô hướng; lợi ích chỉ đến từ việc gộp phép cộng/min/max (xem --bench).
+AVX2_TARGET MetricSummary summarizeMetricsAvx2(const Process* p, size_t n) {
+    const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                               _mm256_set1_epi32((int)sizeof(Process)));
+    __m256i sumW = _mm256_setzero_si256(), sumT = _mm256_setzero_si256();
+    __m256i minW = _mm256_set1_epi32(INT_MAX), maxW = _mm256_set1_epi32(INT_MIN);
+    __m256i minT = _mm256_set1_epi32(INT_MAX), maxT = _mm256_set1_epi32(INT_MIN);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i w = _mm256_i32gather_epi32(&p[i].waiting, offsets, 1);
+        __m256i t = _mm256_i32gather_epi32(&p[i].turnaround, offsets, 1);
+        sumW = addWidened(sumW, w);
+        sumT = addWidened(sumT, t);
+        minW = _mm256_min_epi32(minW, w);
+        maxW = _mm256_max_epi32(maxW, w);
+        minT = _mm256_min_epi32(minT, t);
+        maxT = _mm256_max_epi32(maxT, t);
+    }
+
+    MetricSummary m = summarizeMetricsScalar(p + i, n - i);
+    m.totalWaiting += horizontalSum64(sumW);
+    m.totalTurnaround += horizontalSum64(sumT);
+    m.minWaiting = min(m.minWaiting, horizontalMin32(minW));
+    m.maxWaiting = max(m.maxWaiting, horizontalMax32(maxW));
+    m.minTurnaround = min(m.minTurnaround, horizontalMin32(minT));
+    m.maxTurnaround = max(m.maxTurnaround, horizontalMax32(maxT));
+    return m;
+}
+#endif
+
+MetricSummary summarizeMetrics(const vector<Process>& processes) {
+#ifdef HAVE_AVX2_DISPATCH
+    if (processes.size() >= PARALLEL_THRESHOLD && cpuHasAvx2()) {
+        return summarizeMetricsAvx2(processes.data(), processes.size());
+    }
+#endif
+    return summarizeMetricsScalar(processes.data(), processes.size());
+}
+
+// Cộng dồn double tuần tự (cách tính gốc)
+pair<double, double> calculateAveragesSequential(const vector<Process>& processes) {
     if (processes.empty()) return {0.0, 0.0};
     double totalWaiting = 0, totalTurnaround = 0;
     for (const auto& p : processes) {
@@ -67,12 +224,37 @@ pair<double, double> calculateAverages(const vector<Process>& processes) {
     return {totalWaiting / processes.size(), totalTurnaround / processes.size()};
 }
 
-void printResults(const string& algorithmName, vector<Process>& processes, bool showPriority = false, bool showQueue = false) {
-    // Sắp xếp lại theo Process ID để dễ xem
+// Mọi tổng riêng phần của cộng dồn double đều biểu diễn chính xác khi n * max|x| <= 2^53;
+// khi đó tổng int64 trùng khớp từng bit với tổng double tuần tự
+bool sumsExactInDouble(const MetricSummary& m, size_t n) {
+    long long maxAbs = 0;
+    for (long long v : {(long long)m.minWaiting, (long long)m.maxWaiting,
+                        (long long)m.minTurnaround, (long long)m.maxTurnaround}) {
+        maxAbs = max(maxAbs, v < 0 ? -v : v);
+    }
+    return maxAbs == 0 || (long long)n <= (1LL << 53) / maxAbs;
+}
+
+pair<double, double> calculateAverages(const vector<Process>& processes) {
+    if (processes.size() >= PARALLEL_THRESHOLD) {
+        MetricSummary m = summarizeMetrics(processes);
+        if (sumsExactInDouble(m, processes.size())) {
+            return {(double)m.totalWaiting / processes.size(), (double)m.totalTurnaround / processes.size()};
+        }
+    }
+    return calculateAveragesSequential(processes);
+}
+
+// Sắp xếp lại theo Process ID để dễ xem
+void sortById(vector<Process>& processes) {
     sort(processes.begin(), processes.end(), 
          [](const Process& a, const Process& b) { 
              return a.id < b.id; 
          });
+}
+
+void printResults(const string& algorithmName, vector<Process>& processes, bool showPriority = false, bool showQueue = false) {
+    sortById(processes);
          
     cout << "\n========================================" << endl;
     cout << "  " << algorithmName << endl;
@@ -127,18 +309,77 @@ void printResults(const string& algorithmName, vector<Process>& processes, bool
          << fixed << setprecision(2) << avgTurnaround << endl;
 }
 
-vector<Process> fcfs(vector<Process> processes) {
-    sort(processes.begin(), processes.end(), 
-         [](const Process& a, const Process& b) { return a.arrival < b.arrival; });
-    
-    int currentTime = 0;
-    for (auto& p : processes) {
+// FCFS tuần tự trên đoạn [begin, end) của mảng đã sắp xếp, trả về thời điểm CPU rảnh
+int fcfsScanRange(vector<Process>& processes, size_t begin, size_t end, int currentTime) {
+    for (size_t i = begin; i < end; i++) {
+        Process& p = processes[i];
         p.start = max(currentTime, p.arrival);
         p.finish = p.start + p.burst;
         p.waiting = p.start - p.arrival;
         p.turnaround = p.finish - p.arrival;
         currentTime = p.finish;
     }
+    return currentTime;
+}
+
+// Mỗi tiến trình biến thời điểm CPU rảnh t thành max(t, arrival) + burst = max(t + shift, floor).
+// Ghép hai hàm dạng này vẫn ra cùng dạng (phép max-plus có tính kết hợp), nên FCFS là một phép quét tiền tố.
+struct MaxPlusStep {
+    long long shift;
+    long long floor;
+    long long apply(long long t) const { return max(t + shift, floor); }
+};
+
+// Quét song song 3 pha: (1) mỗi luồng gộp đoạn của mình thành một MaxPlusStep,
+// (2) quét tuần tự các bước gộp để có thời điểm bắt đầu của từng đoạn,
+// (3) mỗi luồng chạy lại vòng FCFS gốc trên đoạn của mình -> kết quả trùng khớp từng bit với bản tuần tự.
+void fcfsScanParallel(vector<Process>& processes, unsigned threads) {
+    size_t n = processes.size();
+    threads = max(1u, min<unsigned>(threads, (unsigned)n));
+    size_t chunk = (n + threads - 1) / threads;
+    vector<MaxPlusStep> steps(threads, {0, LLONG_MIN / 2});
+
+    auto forEachChunk = [&](auto&& body) {
+        vector<thread> pool;
+        for (unsigned c = 0; c < threads; c++) {
+            size_t begin = c * chunk, end = min(n, begin + chunk);
+            if (begin < end) pool.emplace_back(body, c, begin, end);
+        }
+        for (auto& t : pool) t.join();
+    };
+
+    forEachChunk([&](unsigned c, size_t begin, size_t end) {
+        MaxPlusStep s{0, LLONG_MIN / 2};
+        for (size_t i = begin; i < end; i++) {
+            long long b = processes[i].burst;
+            s = {s.shift + b, max(s.floor + b, (long long)processes[i].arrival + b)};
+        }
+        steps[c] = s;
+    });
+
+    vector<int> chunkStart(threads);
+    long long t = 0;
+    for (unsigned c = 0; c < threads; c++) {
+        chunkStart[c] = (int)t;
+        t = steps[c].apply(t);
+    }
+
+    forEachChunk([&](unsigned c, size_t begin, size_t end) {
+        fcfsScanRange(processes, begin, end, chunkStart[c]);
+    });
+}
+
+// threads là số luồng tối đa được dùng cho quét song song; nơi gọi đã chạy song song
+// (batch, Monte Carlo, server) giữ mặc định 1 để không tạo workers x cores luồng
+vector<Process> fcfs(vector<Process> processes, unsigned threads = 1) {
+    sort(processes.begin(), processes.end(), 
+         [](const Process& a, const Process& b) { return a.arrival < b.arrival; });
+    
+    if (processes.size() >= PARALLEL_THRESHOLD && threads > 1) {
+        fcfsScanParallel(processes, threads);
+    } else {
+        fcfsScanRange(processes, 0, processes.size(), 0);
+    }
     
     return processes;
 }
@@ -324,7 +565,7 @@ vector<Process> roundRobin(vector<Process> processes, int quantum) {
 // Queue 0: Priority cao (FCFS)
 // Queue 1: Priority trung bình (Round Robin q=2)
 // Queue 2: Priority thấp (Round Robin q=4)
-vector<Process> mlq(vector<Process> processes) {
+vector<Process> mlq(vector<Process> processes, unsigned threads = 1) {
     // MLQ là Non-preemptive giữa các Queue: Q0 phải hoàn thành -> Q1 chạy -> Q2 chạy
     vector<vector<Process>> queues(3);
     
@@ -346,7 +587,7 @@ vector<Process> mlq(vector<Process> processes) {
     int currentTime = 0;
     
     // 1. Xử lý Queue 0 (FCFS)
-    auto q0Result = fcfs(queues[0]);
+    auto q0Result = fcfs(queues[0], threads);
     for (auto& p : q0Result) {
         currentTime = max(currentTime, p.finish); // Cập nhật thời gian kết thúc của Q0
         result.push_back(p);
@@ -513,21 +754,15 @@ vector<Process> mlfq(vector<Process> processes) {
     return result;
 }
 
-void writeResultsToFile(const string& filename, 
-                        const vector<Process>& fcfsResult,
-                        const vector<Process>& sjfResult,
-                        const vector<Process>& priorityResult,
-                        const vector<Process>& rrResult,
-                        const vector<Process>& mlqResult,
-                        const vector<Process>& mlfqResult,
-                        int quantum) {
-    ofstream file(filename);
-    
-    if (!file.is_open()) {
-        cout << "Khong the tao file output!" << endl;
-        return;
-    }
-    
+// Ghi báo cáo đầy đủ ra một luồng (dùng chung cho chế độ tương tác và batch)
+void writeResults(ostream& file,
+                  const vector<Process>& fcfsResult,
+                  const vector<Process>& sjfResult,
+                  const vector<Process>& priorityResult,
+                  const vector<Process>& rrResult,
+                  const vector<Process>& mlqResult,
+                  const vector<Process>& mlfqResult,
+                  int quantum) {
     file << "=== KET QUA MO PHONG THUAT TOAN LAP LICH CPU ===" << endl << endl;
     
     // FCFS
@@ -624,6 +859,24 @@ void writeResultsToFile(const string& filename,
     file << "  Uu diem: Linh hoat, tu dong dieu chinh priority, phat hien I/O-bound vs CPU-bound" << endl;
     file << "  Nhuoc diem: Phuc tap, overhead cao" << endl;
     file << "  Cau truc: Q0(RR q=2), Q1(RR q=4), Q2(FCFS)" << endl;
+}
+
+void writeResultsToFile(const string& filename, 
+                        const vector<Process>& fcfsResult,
+                        const vector<Process>& sjfResult,
+                        const vector<Process>& priorityResult,
+                        const vector<Process>& rrResult,
+                        const vector<Process>& mlqResult,
+                        const vector<Process>& mlfqResult,
+                        int quantum) {
+    ofstream file(filename);
+    
+    if (!file.is_open()) {
+        cout << "Khong the tao file output!" << endl;
+        return;
+    }
+    
+    writeResults(file, fcfsResult, sjfResult, priorityResult, rrResult, mlqResult, mlfqResult, quantum);
     
     file.close();
     cout << "\n==> Da ghi ket qua vao file: " << filename << endl;
@@ -677,7 +930,1145 @@ void compareAlgorithms(const vector<Process>& fcfsResult,
          << setw(20) << mlfqT << endl;
 }
 
-int main() {
+// ================== CHE DO BATCH ==================
+
+// Kết quả của cả 6 thuật toán trên cùng một bộ tiến trình
+struct SimulationResults {
+    vector<Process> fcfs, sjf, priority, rr, mlq, mlfq;
+    int quantum = 2;
+};
+
+// threads: số luồng cho phép dùng bên trong một lần mô phỏng (xem fcfs())
+SimulationResults runAllAlgorithms(const vector<Process>& processes, int quantum, unsigned threads = 1) {
+    SimulationResults r;
+    r.quantum = quantum;
+    r.fcfs = fcfs(processes, threads);
+    r.sjf = sjf(processes);
+    r.priority = priorityScheduling(processes);
+    r.rr = roundRobin(processes, quantum);
+    r.mlq = mlq(processes, threads);
+    r.mlfq = mlfq(processes);
+    return r;
+}
+
+// Hàng đợi có giới hạn giữa các giai đoạn pipeline:
+// push() chặn khi đầy, pop() chặn khi rỗng và trả về nullopt khi đã close() và hết phần tử
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(max<size_t>(capacity, 1)) {}
+
+    void push(T item) {
+        unique_lock<mutex> lock(mtx);
+        notFull.wait(lock, [this] { return items.size() < capacity; });
+        items.push(std::move(item));
+        notEmpty.notify_one();
+    }
+
+    optional<T> pop() {
+        unique_lock<mutex> lock(mtx);
+        notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+        if (items.empty()) return nullopt;
+        T item = std::move(items.front());
+        items.pop();
+        notFull.notify_one();
+        return item;
+    }
+
+    void close() {
+        lock_guard<mutex> lock(mtx);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    size_t capacity;
+    queue<T> items;
+    bool closed = false;
+    mutex mtx;
+    condition_variable notEmpty, notFull;
+};
+
+struct BatchConfig {
+    vector<string> inputs;      // File trace hoặc thư mục chứa các file .txt
+    string outputDir = ".";
+    int quantum = 2;
+    int workers = 0;            // 0 = số luồng phần cứng
+    int queueCapacity = 0;      // 0 = 2 * workers
+};
+
+struct TraceJob {
+    string name;
+    vector<Process> processes;
+};
+
+struct ReportJob {
+    string name;
+    SimulationResults results;
+};
+
+void printBatchUsage() {
+    cout << "Cach dung: update1 --batch [--config FILE] [--quantum N] [--output DIR]\n"
+         << "                    [--workers N] [--queue N] <file|thu_muc>...\n"
+         << "File config gom cac dong 'key=value' voi key: quantum, output, workers, queue, input" << endl;
+}
+
+// Đọc file config dạng key=value; trả về false nếu không mở được hoặc có key lạ
+bool loadBatchConfig(const string& filename, BatchConfig& config) {
+    ifstream file(filename);
+    if (!file.is_open()) {
+        cout << "Khong the mo file config: " << filename << endl;
+        return false;
+    }
+    auto trim = [](string text) {
+        text.erase(0, text.find_first_not_of(" \t"));
+        text.erase(text.find_last_not_of(" \t\r") + 1);
+        return text;
+    };
+    string line;
+    while (getline(file, line)) {
+        line = trim(line);    // Bỏ cả '\r' của file config soạn trên Windows
+        if (line.empty() || line[0] == '#') continue;
+        size_t eq = line.find('=');
+        if (eq == string::npos) continue;
+        string key = trim(line.substr(0, eq)), value = trim(line.substr(eq + 1));
+        if (key == "quantum") config.quantum = stoi(value);
+        else if (key == "output") config.outputDir = value;
+        else if (key == "workers") config.workers = stoi(value);
+        else if (key == "queue") config.queueCapacity = stoi(value);
+        else if (key == "input") config.inputs.push_back(value);
+        else {
+            cout << "Key khong hop le trong config: " << key << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseBatchArgs(int argc, char* argv[], BatchConfig& config) {
+    try {
+        for (int i = 2; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--config" && hasValue) {
+                if (!loadBatchConfig(argv[++i], config)) return false;
+            } else if (arg == "--quantum" && hasValue) {
+                config.quantum = stoi(argv[++i]);
+            } else if (arg == "--output" && hasValue) {
+                config.outputDir = argv[++i];
+            } else if (arg == "--workers" && hasValue) {
+                config.workers = stoi(argv[++i]);
+            } else if (arg == "--queue" && hasValue) {
+                config.queueCapacity = stoi(argv[++i]);
+            } else if (arg.rfind("--", 0) == 0) {
+                cout << "Tham so khong hop le: " << arg << endl;
+                return false;
+            } else {
+                config.inputs.push_back(arg);
+            }
+        }
+    } catch (const exception&) {
+        cout << "Gia tri tham so khong hop le" << endl;
+        return false;
+    }
+    if (config.quantum <= 0) {
+        cout << "Quantum phai lon hon 0" << endl;
+        return false;
+    }
+    return !config.inputs.empty();
+}
+
+const string REPORT_SUFFIX = ".out.txt";
+
+struct TraceFile {
+    string path;
+    string reportName;  // Đường dẫn tương đối (không có .txt) dùng để đặt tên báo cáo
+};
+
+bool endsWith(const string& text, const string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Mở rộng đệ quy các thư mục thành danh sách file .txt (sắp xếp theo tên để thứ tự ổn định).
+// Tên báo cáo giữ đường dẫn tương đối so với thư mục đầu vào; bỏ qua các báo cáo *.out.txt của chính công cụ.
+// Thư mục không đọc được được báo lỗi, bỏ qua và cộng vào unreadable thay vì dừng cả lượt chạy.
+vector<TraceFile> collectTraceFiles(const vector<string>& inputs, int& unreadable) {
+    vector<TraceFile> files;
+    for (const auto& input : inputs) {
+        error_code ec;
+        if (fs::is_directory(input, ec)) {
+            vector<TraceFile> dirFiles;
+            fs::recursive_directory_iterator it(input, ec), end;
+            if (ec) {
+                cout << "Khong the doc thu muc: " << input << " (" << ec.message() << ")" << endl;
+                unreadable++;
+                continue;
+            }
+            while (it != end) {
+                const fs::path path = it->path();
+                error_code entryError;
+                if (it->is_directory(entryError)) {
+                    // increment() lỗi khi vào thư mục con sẽ kết thúc cả vòng duyệt, nên thử mở trước
+                    fs::directory_iterator probe(path, entryError);
+                    if (entryError) {
+                        cout << "Khong the doc thu muc: " << path.string() << " (" << entryError.message() << ")" << endl;
+                        unreadable++;
+                        it.disable_recursion_pending();
+                    }
+                } else if (it->is_regular_file(entryError) && path.extension() == ".txt" &&
+                           !endsWith(path.filename().string(), REPORT_SUFFIX)) {
+                    fs::path relative = path.lexically_relative(input);
+                    relative.replace_extension();
+                    dirFiles.push_back({path.string(), relative.generic_string()});
+                }
+                it.increment(ec);
+                if (ec) {
+                    cout << "Loi khi duyet thu muc: " << input << " (" << ec.message() << ")" << endl;
+                    unreadable++;
+                    break;
+                }
+            }
+            sort(dirFiles.begin(), dirFiles.end(),
+                 [](const TraceFile& a, const TraceFile& b) { return a.path < b.path; });
+            files.insert(files.end(), dirFiles.begin(), dirFiles.end());
+        } else {
+            files.push_back({input, fs::path(input).stem().string()});
+        }
+    }
+    return files;
+}
+
+// Pipeline 3 giai đoạn: 1 luồng đọc trace -> N luồng mô phỏng -> 1 luồng ghi báo cáo.
+// Các giai đoạn nối với nhau bằng BoundedQueue nên việc đọc trace kế tiếp, mô phỏng trace
+// hiện tại và ghi báo cáo trước đó diễn ra chồng lấp, bộ nhớ bị giới hạn bởi kích thước hàng đợi.
+int runBatchMode(int argc, char* argv[]) {
+    BatchConfig config;
+    if (!parseBatchArgs(argc, argv, config)) {
+        printBatchUsage();
+        return 1;
+    }
+
+    int unreadable = 0;
+    vector<TraceFile> files = collectTraceFiles(config.inputs, unreadable);
+    if (files.empty()) {
+        cout << "Khong tim thay file trace nao!" << endl;
+        return 1;
+    }
+
+    // Hai trace cùng tên báo cáo sẽ ghi đè lên nhau -> dừng trước khi chạy
+    map<string, string> reportOwners;
+    for (const auto& f : files) {
+        auto [it, inserted] = reportOwners.emplace(f.reportName, f.path);
+        if (!inserted) {
+            cout << "Trung ten bao cao '" << f.reportName << REPORT_SUFFIX << "': "
+                 << it->second << " va " << f.path << endl;
+            return 1;
+        }
+    }
+
+    error_code ec;
+    fs::create_directories(config.outputDir, ec);
+    if (ec) {
+        cout << "Khong the tao thu muc output: " << config.outputDir << endl;
+        return 1;
+    }
+
+    int workers = config.workers > 0 ? config.workers : (int)max(1u, thread::hardware_concurrency());
+    int capacity = config.queueCapacity > 0 ? config.queueCapacity : 2 * workers;
+    // Chia số lõi còn lại cho từng worker để tổng số luồng không vượt quá số lõi
+    unsigned threadsPerTrace = max(1u, thread::hardware_concurrency() / (unsigned)workers);
+
+    BoundedQueue<TraceJob> loadQueue(capacity);
+    BoundedQueue<ReportJob> reportQueue(capacity);
+    mutex logMutex;
+    atomic<int> failed(unreadable);
+    int written = 0;
+
+    auto log = [&](const string& msg) {
+        lock_guard<mutex> lock(logMutex);
+        cout << msg << endl;
+    };
+
+    cout << "Batch: " << files.size() << " trace, " << workers << " luong mo phong, quantum="
+         << config.quantum << endl;
+
+    thread loader([&] {
+        for (const auto& trace : files) {
+            ifstream file(trace.path);
+            if (!file.is_open()) {
+                log("Khong the mo file: " + trace.path);
+                failed++;
+                continue;
+            }
+            TraceJob job{trace.reportName, {}};
+            string error;
+            if (!parseProcesses(file, job.processes, error)) {
+                log(trace.path + ": " + error);
+                failed++;
+                continue;
+            }
+            if (job.processes.empty()) {
+                log("Khong co du lieu tien trinh: " + trace.path);
+                failed++;
+                continue;
+            }
+            loadQueue.push(std::move(job));
+        }
+        loadQueue.close();
+    });
+
+    vector<thread> simulators;
+    for (int w = 0; w < workers; w++) {
+        simulators.emplace_back([&] {
+            while (auto job = loadQueue.pop()) {
+                SimulationResults r = runAllAlgorithms(job->processes, config.quantum, threadsPerTrace);
+                // Cùng thứ tự dòng với báo cáo của chế độ tương tác
+                for (auto* result : {&r.fcfs, &r.sjf, &r.priority, &r.rr, &r.mlq, &r.mlfq}) {
+                    sortById(*result);
+                }
+                reportQueue.push({job->name, std::move(r)});
+            }
+        });
+    }
+
+    thread writer([&] {
+        while (auto report = reportQueue.pop()) {
+            fs::path outFile = fs::path(config.outputDir) / (report->name + REPORT_SUFFIX);
+            string outPath = outFile.string();
+            error_code dirError;
+            fs::create_directories(outFile.parent_path(), dirError);
+            ofstream file(outPath);
+            if (!file.is_open()) {
+                log("Khong the tao file output: " + outPath);
+                failed++;
+                continue;
+            }
+            const SimulationResults& r = report->results;
+            writeResults(file, r.fcfs, r.sjf, r.priority, r.rr, r.mlq, r.mlfq, r.quantum);
+            written++;
+        }
+    });
+
+    loader.join();
+    for (auto& t : simulators) t.join();
+    reportQueue.close();
+    writer.join();
+
+    cout << "\n==> Da ghi " << written << " bao cao vao thu muc: " << config.outputDir;
+    if (failed > 0) cout << " (" << failed << " trace loi)";
+    cout << endl;
+    return failed > 0 ? 1 : 0;
+}
+
+// ================== MONTE CARLO ==================
+
+static inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Bộ sinh ngẫu nhiên dựa trên bộ đếm: số thứ k của luồng (seed, stream) chỉ phụ thuộc vào
+// (seed, stream, k), nên mỗi lần lặp có luồng riêng và kết quả không phụ thuộc số luồng CPU
+struct CounterRng {
+    uint64_t key;
+    uint64_t counter = 0;
+
+    CounterRng(uint64_t seed, uint64_t stream) : key(splitmix64(seed ^ splitmix64(stream))) {}
+
+    uint64_t next() { return splitmix64(key ^ splitmix64(counter++)); }
+    double uniform() { return (next() >> 11) * 0x1.0p-53; }   // [0, 1)
+};
+
+// Phân phối của một đại lượng nguyên: "const:v", "uniform:lo:hi" (gồm cả hai đầu) hoặc "exp:mean"
+struct Distribution {
+    enum Kind { Constant, Uniform, Exponential } kind = Constant;
+    double a = 0, b = 0;
+
+    int sample(CounterRng& rng) const {
+        switch (kind) {
+            case Uniform: return (int)a + (int)(rng.uniform() * (b - a + 1));
+            case Exponential: return (int)llround(-a * log(1.0 - rng.uniform()));
+            default: return (int)a;
+        }
+    }
+};
+
+struct WorkloadSpec {
+    int count = 50;
+    Distribution interarrival{Distribution::Exponential, 4};
+    Distribution burst{Distribution::Exponential, 6};
+    Distribution priority{Distribution::Uniform, 1, 3};
+};
+
+bool parseDistribution(const string& text, Distribution& dist) {
+    vector<string> parts;
+    stringstream ss(text);
+    string part;
+    while (getline(ss, part, ':')) parts.push_back(part);
+    try {
+        if (parts.size() == 1) {
+            dist = {Distribution::Constant, stod(parts[0])};
+        } else if (parts.size() == 2 && parts[0] == "const") {
+            dist = {Distribution::Constant, stod(parts[1])};
+        } else if (parts.size() == 2 && parts[0] == "exp" && stod(parts[1]) >= 0) {
+            dist = {Distribution::Exponential, stod(parts[1])};
+        } else if (parts.size() == 3 && parts[0] == "uniform") {
+            // Chỉ lấy các giá trị nguyên nằm trong [lo, hi]
+            double lo = ceil(stod(parts[1])), hi = floor(stod(parts[2]));
+            if (lo > hi) return false;
+            dist = {Distribution::Uniform, lo, hi};
+        } else {
+            return false;
+        }
+    } catch (const exception&) {
+        return false;
+    }
+    return true;
+}
+
+// Cú pháp: "n=50,interarrival=exp:4,burst=exp:6,priority=uniform:1:3" (các key có thể bỏ qua)
+bool parseWorkloadSpec(const string& text, WorkloadSpec& spec) {
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == string::npos) return false;
+        string key = item.substr(0, eq), value = item.substr(eq + 1);
+        bool ok = true;
+        if (key == "n") {
+            try { spec.count = stoi(value); } catch (const exception&) { ok = false; }
+            ok = ok && spec.count > 0;
+        }
+        else if (key == "interarrival") ok = parseDistribution(value, spec.interarrival);
+        else if (key == "burst") ok = parseDistribution(value, spec.burst);
+        else if (key == "priority") ok = parseDistribution(value, spec.priority);
+        else ok = false;
+        if (!ok) {
+            cout << "Phan phoi khong hop le: " << item << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+vector<Process> generateWorkload(const WorkloadSpec& spec, CounterRng& rng) {
+    vector<Process> processes;
+    processes.reserve(spec.count);
+    int arrival = 0;
+    for (int i = 0; i < spec.count; i++) {
+        if (i > 0) arrival += max(0, spec.interarrival.sample(rng));
+        int burst = max(1, spec.burst.sample(rng));
+        int priority = max(0, spec.priority.sample(rng));
+        processes.push_back(Process("P" + to_string(i + 1), arrival, burst, priority));
+    }
+    return processes;
+}
+
+// Giá trị tới hạn t(0.975, df) cho khoảng tin cậy 95%. Ngoài bảng thì làm tròn df xuống
+// mốc gần nhất (giá trị tới hạn lớn hơn) để khoảng tin cậy không bị hẹp đi
+double studentT975(int df) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df <= 30) return table[max(df, 1) - 1];
+    if (df < 40) return table[29];
+    if (df < 60) return 2.021;
+    if (df < 120) return 2.000;
+    return 1.980;
+}
+
+// Trung bình và nửa độ rộng khoảng tin cậy 95% của một mẫu
+pair<double, double> meanWithConfidence(const vector<double>& samples) {
+    size_t k = samples.size();
+    double mean = 0;
+    for (double x : samples) mean += x;
+    mean /= k;
+    if (k < 2) return {mean, 0.0};
+    double sq = 0;
+    for (double x : samples) sq += (x - mean) * (x - mean);
+    double stddev = sqrt(sq / (k - 1));
+    return {mean, studentT975((int)k - 1) * stddev / sqrt((double)k)};
+}
+
+// Sinh K workload độc lập (mỗi workload một luồng RNG riêng), chạy 6 thuật toán trên từng workload
+// song song, rồi tổng hợp theo thứ tự lần lặp để kết quả chỉ phụ thuộc vào seed
+int runMonteCarlo(int argc, char* argv[]) {
+    WorkloadSpec spec;
+    int replications = 100, quantum = 2, workers = 0;
+    uint64_t seed = 1;
+    try {
+        for (int i = 2; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--dist" && hasValue) {
+                if (!parseWorkloadSpec(argv[++i], spec)) return 1;
+            } else if (arg == "--replications" && hasValue) {
+                replications = stoi(argv[++i]);
+            } else if (arg == "--seed" && hasValue) {
+                seed = stoull(argv[++i]);
+            } else if (arg == "--quantum" && hasValue) {
+                quantum = stoi(argv[++i]);
+            } else if (arg == "--workers" && hasValue) {
+                workers = stoi(argv[++i]);
+            } else {
+                throw invalid_argument(arg);
+            }
+        }
+        // Cần ít nhất 2 lần lặp để ước lượng phương sai cho khoảng tin cậy
+        if (replications < 2 || quantum <= 0) throw invalid_argument("range");
+    } catch (const exception&) {
+        cout << "Cach dung: update1 --montecarlo [--dist SPEC] [--replications K>=2] [--seed S]\n"
+             << "                         [--quantum N] [--workers N]\n"
+             << "SPEC vi du: n=50,interarrival=exp:4,burst=uniform:1:10,priority=uniform:1:3" << endl;
+        return 1;
+    }
+    if (workers <= 0) workers = (int)max(1u, thread::hardware_concurrency());
+
+    const int algorithmCount = 6;
+    // averages[algo][rep] = {avg waiting, avg turnaround}
+    vector<vector<pair<double, double>>> averages(algorithmCount, vector<pair<double, double>>(replications));
+    atomic<int> nextReplication(0);
+
+    vector<thread> pool;
+    for (int w = 0; w < workers; w++) {
+        pool.emplace_back([&] {
+            for (int rep = nextReplication++; rep < replications; rep = nextReplication++) {
+                CounterRng rng(seed, (uint64_t)rep);
+                SimulationResults r = runAllAlgorithms(generateWorkload(spec, rng), quantum);
+                const vector<Process>* results[algorithmCount] = {&r.fcfs, &r.sjf, &r.priority, &r.rr, &r.mlq, &r.mlfq};
+                for (int a = 0; a < algorithmCount; a++) {
+                    averages[a][rep] = calculateAverages(*results[a]);
+                }
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+
+    const string names[algorithmCount] = {
+        "FCFS", "SJF", "Priority", "Round Robin (q=" + to_string(quantum) + ")", "MLQ", "MLFQ"
+    };
+
+    cout << "Monte Carlo: " << replications << " lan lap, " << spec.count << " tien trinh/lan, seed="
+         << seed << ", " << workers << " luong" << endl;
+    cout << "Khoang tin cay 95% (trung binh +/- nua do rong)\n" << endl;
+    cout << left << setw(25) << "Thuat toan"
+         << setw(26) << "Avg Waiting"
+         << setw(26) << "Avg Turnaround" << endl;
+    cout << string(77, '-') << endl;
+    for (int a = 0; a < algorithmCount; a++) {
+        vector<double> waiting, turnaround;
+        for (const auto& [w, t] : averages[a]) {
+            waiting.push_back(w);
+            turnaround.push_back(t);
+        }
+        auto [wMean, wHalf] = meanWithConfidence(waiting);
+        auto [tMean, tHalf] = meanWithConfidence(turnaround);
+        ostringstream wCell, tCell;
+        wCell << fixed << setprecision(3) << wMean << " +/- " << wHalf;
+        tCell << fixed << setprecision(3) << tMean << " +/- " << tHalf;
+        cout << left << setw(25) << names[a] << setw(26) << wCell.str() << setw(26) << tCell.str() << endl;
+    }
+    return 0;
+}
+
+// ================== CHE DO SERVER ==================
+
+// Server HTTP cục bộ (chỉ lắng nghe 127.0.0.1) cho giao diện update_cs.html.
+//   POST /traces    body: nội dung trace          -> {"id": "...", "count": N}
+//   POST /simulate  {"trace": id, "algorithm": "fcfs|sjf|priority|rr|mlq|mlfq", "quantum": 2}
+//   POST /compare   {"trace": id, "quantum": 2}    -> kết quả của cả 6 thuật toán
+//   GET  /health
+// Trace đã parse được giữ trong bộ nhớ theo id nên các truy vấn lặp lại không phải đọc lại dữ liệu.
+// Host phải là loopback (chặn DNS rebinding) và Origin phải là "null" hoặc trang chạy trên loopback.
+// Origin "null" không chỉ đến từ file:// mà cả iframe sandbox hay trang data: của bất kỳ website nào,
+// nên mọi request trừ GET /health còn phải gửi token phiên (header X-Session-Token) mà --server in ra
+// lúc khởi động; trang web lạ không biết token nên không dùng được server.
+
+// SJF/Priority/MLFQ là O(n^2): 5000 tiến trình cho /compare chạy dưới 0.5 giây, 10000 đã mất ~1.5 giây.
+// Round Robin tốn thời gian theo số lát thời gian (burst / quantum), nên cũng bị giới hạn riêng.
+// Trace lớn hơn dùng chế độ --batch.
+const size_t MAX_SERVER_PROCESSES = 5000;
+const long long MAX_SERVER_TIME_SLICES = 2000000;
+const size_t MAX_REQUEST_BODY = 1u << 20;
+const size_t MAX_RESIDENT_TRACES = 64;
+const int MAX_CONNECTIONS = 16;
+const int SOCKET_TIMEOUT_SECONDS = 5;
+const int REQUEST_DEADLINE_SECONDS = 15;
+
+// Kho trace dùng chung giữa các luồng xử lý kết nối. Id gồm tiền tố ngẫu nhiên của phiên server
+// và một bộ đếm, nên id cũ từ phiên trước không trỏ nhầm sang trace khác. Khi vượt giới hạn
+// số trace, trace ít được dùng gần đây nhất bị loại (LRU).
+class TraceStore {
+public:
+    TraceStore() {
+        ostringstream prefix;
+        prefix << hex << (random_device{}() & 0xffffff) << "-";
+        idPrefix = prefix.str();
+    }
+
+    string add(shared_ptr<const vector<Process>> processes) {
+        lock_guard<mutex> lock(mtx);
+        string id = idPrefix + to_string(++nextId);
+        recent.push_front(id);
+        traces[id] = {processes, recent.begin()};
+        if (traces.size() > MAX_RESIDENT_TRACES) {
+            traces.erase(recent.back());
+            recent.pop_back();
+        }
+        return id;
+    }
+
+    shared_ptr<const vector<Process>> get(const string& id) {
+        lock_guard<mutex> lock(mtx);
+        auto it = traces.find(id);
+        if (it == traces.end()) return nullptr;
+        recent.splice(recent.begin(), recent, it->second.position);
+        return it->second.processes;
+    }
+
+private:
+    struct Entry {
+        shared_ptr<const vector<Process>> processes;
+        list<string>::iterator position;
+    };
+
+    mutex mtx;
+    map<string, Entry> traces;
+    list<string> recent;    // Đầu danh sách = dùng gần đây nhất
+    unsigned long long nextId = 0;
+    string idPrefix;
+};
+
+// Giới hạn số kết nối được xử lý đồng thời
+class ConnectionLimiter {
+public:
+    explicit ConnectionLimiter(int limit) : available(limit) {}
+
+    void acquire() {
+        unique_lock<mutex> lock(mtx);
+        freed.wait(lock, [this] { return available > 0; });
+        available--;
+    }
+
+    void release() {
+        lock_guard<mutex> lock(mtx);
+        available++;
+        freed.notify_one();
+    }
+
+private:
+    int available;
+    mutex mtx;
+    condition_variable freed;
+};
+
+string jsonEscape(const string& text) {
+    string out;
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+// Parse một object JSON phẳng {"key": "string" | number | true/false}; giá trị lồng nhau không được hỗ trợ
+bool parseFlatJson(const string& text, map<string, string>& fields) {
+    size_t i = 0;
+    auto skipSpace = [&] { while (i < text.size() && isspace((unsigned char)text[i])) i++; };
+    auto readString = [&](string& out) {
+        if (i >= text.size() || text[i] != '"') return false;
+        for (i++; i < text.size() && text[i] != '"'; i++) {
+            if (text[i] == '\\' && i + 1 < text.size()) {
+                char e = text[++i];
+                out += e == 'n' ? '\n' : e == 't' ? '\t' : e == 'r' ? '\r' : e;
+            } else {
+                out += text[i];
+            }
+        }
+        if (i >= text.size()) return false;
+        i++;
+        return true;
+    };
+
+    skipSpace();
+    if (i >= text.size() || text[i++] != '{') return false;
+    skipSpace();
+    if (i < text.size() && text[i] == '}') return true;
+    while (i < text.size()) {
+        string key, value;
+        skipSpace();
+        if (!readString(key)) return false;
+        skipSpace();
+        if (i >= text.size() || text[i++] != ':') return false;
+        skipSpace();
+        if (i < text.size() && text[i] == '"') {
+            if (!readString(value)) return false;
+        } else {
+            while (i < text.size() && text[i] != ',' && text[i] != '}' && !isspace((unsigned char)text[i])) {
+                value += text[i++];
+            }
+            if (value.empty()) return false;
+        }
+        fields[key] = value;
+        skipSpace();
+        if (i < text.size() && text[i] == ',') { i++; continue; }
+        return i < text.size() && text[i] == '}';
+    }
+    return false;
+}
+
+string resultToJson(vector<Process> processes) {
+    sortById(processes);
+    auto [avgWaiting, avgTurnaround] = calculateAverages(processes);
+    ostringstream out;
+    out << setprecision(10) << "{\"avgWaiting\":" << avgWaiting << ",\"avgTurnaround\":" << avgTurnaround
+        << ",\"processes\":[";
+    for (size_t i = 0; i < processes.size(); i++) {
+        const Process& p = processes[i];
+        if (i > 0) out << ",";
+        out << "{\"id\":\"" << jsonEscape(p.id) << "\",\"arrival\":" << p.arrival << ",\"burst\":" << p.burst
+            << ",\"priority\":" << p.priority << ",\"queueLevel\":" << p.queueLevel << ",\"start\":" << p.start
+            << ",\"finish\":" << p.finish << ",\"waiting\":" << p.waiting << ",\"turnaround\":" << p.turnaround << "}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+struct HttpResponse {
+    int status = 200;
+    string body;
+};
+
+HttpResponse jsonError(int status, const string& message) {
+    return {status, "{\"error\":\"" + jsonEscape(message) + "\"}"};
+}
+
+// Số lát thời gian Round Robin cần cho một trace (MLQ dùng q=2/4, MLFQ dùng q=2/4 rồi FCFS)
+long long countTimeSlices(const vector<Process>& processes, int quantum) {
+    int smallest = min(quantum, 2);
+    long long slices = 0;
+    for (const auto& p : processes) slices += p.burst / smallest + 1;
+    return slices;
+}
+
+HttpResponse handleRequest(const string& method, const string& path, const string& body, TraceStore& store) {
+    if (method == "GET" && path == "/health") return {200, "{\"status\":\"ok\"}"};
+    if (method != "POST") return jsonError(404, "Khong tim thay: " + method + " " + path);
+
+    if (path == "/traces") {
+        istringstream in(body);
+        vector<Process> parsed;
+        string error;
+        if (!parseProcesses(in, parsed, error)) return jsonError(400, error);
+        if (parsed.empty()) return jsonError(400, "Khong co du lieu tien trinh");
+        if (parsed.size() > MAX_SERVER_PROCESSES) {
+            return jsonError(413, "Trace qua lon cho server (toi da " + to_string(MAX_SERVER_PROCESSES) +
+                                  " tien trinh), hay dung --batch");
+        }
+        size_t count = parsed.size();
+        string id = store.add(make_shared<const vector<Process>>(std::move(parsed)));
+        return {200, "{\"id\":\"" + id + "\",\"count\":" + to_string(count) + "}"};
+    }
+    if (path != "/simulate" && path != "/compare") return jsonError(404, "Khong tim thay: " + path);
+
+    map<string, string> fields;
+    if (!parseFlatJson(body, fields)) return jsonError(400, "JSON khong hop le");
+    auto processes = store.get(fields["trace"]);
+    if (!processes) return jsonError(404, "Trace khong ton tai: " + fields["trace"]);
+    int quantum = 2;
+    if (fields.count("quantum")) {
+        try { quantum = stoi(fields["quantum"]); } catch (const exception&) { quantum = 0; }
+    }
+    if (quantum <= 0) return jsonError(400, "Quantum phai lon hon 0");
+    if (countTimeSlices(*processes, quantum) > MAX_SERVER_TIME_SLICES) {
+        return jsonError(413, "Tong burst / quantum qua lon cho server, hay tang quantum hoac dung --batch");
+    }
+
+    if (path == "/compare") {
+        SimulationResults r = runAllAlgorithms(*processes, quantum);
+        return {200, "{\"quantum\":" + to_string(quantum) + ",\"results\":{"
+                     "\"fcfs\":" + resultToJson(std::move(r.fcfs)) +
+                     ",\"sjf\":" + resultToJson(std::move(r.sjf)) +
+                     ",\"priority\":" + resultToJson(std::move(r.priority)) +
+                     ",\"rr\":" + resultToJson(std::move(r.rr)) +
+                     ",\"mlq\":" + resultToJson(std::move(r.mlq)) +
+                     ",\"mlfq\":" + resultToJson(std::move(r.mlfq)) + "}}"};
+    }
+
+    const string& algorithm = fields["algorithm"];
+    vector<Process> result;
+    if (algorithm == "fcfs") result = fcfs(*processes);
+    else if (algorithm == "sjf") result = sjf(*processes);
+    else if (algorithm == "priority") result = priorityScheduling(*processes);
+    else if (algorithm == "rr") result = roundRobin(*processes, quantum);
+    else if (algorithm == "mlq") result = mlq(*processes);
+    else if (algorithm == "mlfq") result = mlfq(*processes);
+    else return jsonError(400, "Thuat toan khong hop le: " + algorithm);
+    return {200, "{\"algorithm\":\"" + algorithm + "\",\"quantum\":" + to_string(quantum) +
+                 ",\"result\":" + resultToJson(std::move(result)) + "}"};
+}
+
+void sendAll(socket_t client, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int n = send(client, data.data() + sent, (int)min<size_t>(data.size() - sent, 1 << 20), MSG_NOSIGNAL);
+        if (n <= 0) return;
+        sent += n;
+    }
+}
+
+bool isLoopbackName(const string& host) {
+    return host == "127.0.0.1" || host == "localhost";
+}
+
+// Tách "host:port"; port bỏ trống thì dùng defaultPort
+bool splitHostPort(const string& text, string& host, int& port, int defaultPort) {
+    size_t colon = text.rfind(':');
+    if (colon == string::npos) {
+        host = text;
+        port = defaultPort;
+        return true;
+    }
+    host = text.substr(0, colon);
+    string digits = text.substr(colon + 1);
+    if (digits.empty() || digits.size() > 5 || !all_of(digits.begin(), digits.end(), ::isdigit)) return false;
+    port = stoi(digits);
+    return true;
+}
+
+// Host phải là tên loopback với đúng cổng của server (chặn DNS rebinding)
+bool isAllowedHost(const string& value, int serverPort) {
+    string host;
+    int port;
+    return splitHostPort(value, host, port, 80) && isLoopbackName(host) && port == serverPort;
+}
+
+// Origin hợp lệ: "null" (trang mở từ file://) hoặc http://127.0.0.1 / http://localhost với cổng bất kỳ
+bool isAllowedOrigin(const string& origin) {
+    // "null" vẫn phải qua kiểm tra token phiên trong serveConnection
+    const string scheme = "http://";
+    if (origin == "null") return true;
+    if (origin.compare(0, scheme.size(), scheme) != 0) return false;
+    string host;
+    int port;
+    return splitHostPort(origin.substr(scheme.size()), host, port, 80) && isLoopbackName(host);
+}
+
+// Token ngẫu nhiên 128 bit cho một phiên server
+string generateSessionToken() {
+    random_device rd;
+    ostringstream token;
+    token << hex << setfill('0');
+    for (int i = 0; i < 4; i++) token << setw(8) << rd();
+    return token.str();
+}
+
+// So sánh không dừng sớm để thời gian phản hồi không làm lộ token
+bool tokenMatches(const string& given, const string& expected) {
+    if (given.size() != expected.size()) return false;
+    unsigned char diff = 0;
+    for (size_t i = 0; i < given.size(); i++) diff |= given[i] ^ expected[i];
+    return diff == 0;
+}
+
+void setSocketTimeouts(socket_t socket, int seconds) {
+#ifdef _WIN32
+    DWORD timeout = seconds * 1000;
+#else
+    timeval timeout{seconds, 0};
+#endif
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+    setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+}
+
+// Đọc một request HTTP/1.1 (header + body theo Content-Length), trả lời rồi đóng kết nối.
+// Mỗi lần recv có timeout và cả request có hạn chót, nên client chậm không giữ luồng mãi.
+void serveConnection(socket_t client, TraceStore& store, int serverPort, const string& sessionToken) {
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(REQUEST_DEADLINE_SECONDS);
+    auto expired = [&deadline] { return chrono::steady_clock::now() > deadline; };
+
+    string data;
+    char buf[65536];
+    size_t headerEnd;
+    while ((headerEnd = data.find("\r\n\r\n")) == string::npos) {
+        int n = recv(client, buf, sizeof(buf), 0);
+        if (n <= 0 || data.size() > 65536 || expired()) { closeSocket(client); return; }
+        data.append(buf, n);
+    }
+
+    istringstream headers(data.substr(0, headerEnd));
+    string method, path, line, host, origin, token;
+    headers >> method >> path;
+    getline(headers, line);
+    size_t contentLength = 0;
+    while (getline(headers, line)) {
+        size_t colon = line.find(':');
+        if (colon == string::npos) continue;
+        string name = line.substr(0, colon);
+        transform(name.begin(), name.end(), name.begin(), ::tolower);
+        string value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t\r") + 1);
+        if (name == "content-length") contentLength = strtoull(value.c_str(), nullptr, 10);
+        else if (name == "host") host = value;
+        else if (name == "origin") origin = value;
+        else if (name == "x-session-token") token = value;
+    }
+
+    bool originAllowed = !origin.empty() && isAllowedOrigin(origin);
+    HttpResponse response;
+    if (!isAllowedHost(host, serverPort) || (!origin.empty() && !originAllowed)) {
+        response = jsonError(403, "Host/Origin khong duoc phep");
+    } else if (method != "OPTIONS" && !(method == "GET" && path == "/health") &&
+               !tokenMatches(token, sessionToken)) {
+        response = jsonError(401, "Thieu hoac sai token phien (X-Session-Token)");
+    } else if (contentLength > MAX_REQUEST_BODY) {
+        response = jsonError(413, "Request qua lon");
+    } else {
+        string body = data.substr(headerEnd + 4);
+        while (body.size() < contentLength) {
+            int n = recv(client, buf, (int)min(sizeof(buf), contentLength - body.size()), 0);
+            if (n <= 0 || expired()) { closeSocket(client); return; }
+            body.append(buf, n);
+        }
+        body.resize(contentLength);
+        try {
+            if (method == "OPTIONS") response = {204, ""};
+            else response = handleRequest(method, path, body, store);
+        } catch (const exception& e) {
+            response = jsonError(500, e.what());
+        }
+    }
+
+    static const map<int, string> reasons = {
+        {200, "OK"}, {204, "No Content"}, {400, "Bad Request"}, {401, "Unauthorized"}, {403, "Forbidden"},
+        {404, "Not Found"},
+        {413, "Payload Too Large"}, {500, "Internal Server Error"}
+    };
+    ostringstream out;
+    out << "HTTP/1.1 " << response.status << " " << reasons.at(response.status) << "\r\n"
+        << "Content-Type: application/json\r\n";
+    if (originAllowed) {
+        out << "Access-Control-Allow-Origin: " << origin << "\r\n"
+            << "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
+            << "Access-Control-Allow-Headers: Content-Type, X-Session-Token\r\n";
+    }
+    out << "Vary: Origin\r\n"
+        << "Content-Length: " << response.body.size() << "\r\n"
+        << "Connection: close\r\n\r\n"
+        << response.body;
+    sendAll(client, out.str());
+    closeSocket(client);
+}
+
+int runServer(int argc, char* argv[]) {
+    int port = 8080;
+    if (argc > 3 && string(argv[2]) == "--port") port = atoi(argv[3]);
+    if (port <= 0 || port > 65535 || (argc > 2 && argc != 4)) {
+        cout << "Cach dung: update1 --server [--port N]" << endl;
+        return 1;
+    }
+
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+    socket_t server = socket(AF_INET, SOCK_STREAM, 0);
+    if (server == INVALID_SOCKET) {
+        cout << "Khong the tao socket!" << endl;
+        return 1;
+    }
+    int reuse = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(server, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(server, 64) != 0) {
+        cout << "Khong the lang nghe tren cong " << port << endl;
+        closeSocket(server);
+        return 1;
+    }
+
+    string sessionToken = generateSessionToken();
+    cout << "Server dang chay tai http://127.0.0.1:" << port << " (Ctrl+C de dung)" << endl;
+    cout << "Dan URL sau vao o 'Server C++' cua update_cs.html:\n"
+         << "  http://127.0.0.1:" << port << "/?token=" << sessionToken << endl;
+    TraceStore store;
+    ConnectionLimiter limiter(MAX_CONNECTIONS);
+    while (true) {
+        // Khi đủ MAX_CONNECTIONS kết nối, các kết nối mới chờ trong backlog của hệ điều hành
+        limiter.acquire();
+        socket_t client = accept(server, nullptr, nullptr);
+        if (client == INVALID_SOCKET) {
+            limiter.release();
+            continue;
+        }
+        setSocketTimeouts(client, SOCKET_TIMEOUT_SECONDS);
+        thread([client, &store, &limiter, port, &sessionToken] {
+            serveConnection(client, store, port, sessionToken);
+            limiter.release();
+        }).detach();
+    }
+}
+
+// ================== BENCHMARK ==================
+
+// fcfs() gốc (trước khi có quét song song): sắp xếp rồi chạy vòng lặp tuần tự
+vector<Process> fcfsBaseline(vector<Process> processes) {
+    sort(processes.begin(), processes.end(), 
+         [](const Process& a, const Process& b) { return a.arrival < b.arrival; });
+    fcfsScanRange(processes, 0, processes.size(), 0);
+    return processes;
+}
+
+// So sánh fcfs() và calculateAverages() hiện tại với bản gốc trên trace tổng hợp n tiến trình
+// (gồm cả bước sắp xếp), kèm thời gian riêng của từng phần quét/rút gọn
+int runBenchmark(int argc, char* argv[]) {
+    size_t n = 10000000;
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    try {
+        if (argc > 2) n = stoull(argv[2]);
+        if (argc > 3) threads = stoul(argv[3]);
+    } catch (const exception&) {
+        cout << "Cach dung: update1 --bench [so_tien_trinh] [so_luong]" << endl;
+        return 1;
+    }
+
+    // Trace tổng hợp có khoảng nghỉ CPU, sinh bằng LCG cố định để lặp lại được
+    vector<Process> processes;
+    processes.reserve(n);
+    unsigned long long state = 12345;
+    auto next = [&state](int mod) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (int)((state >> 33) % mod);
+    };
+    int arrival = 0;
+    for (size_t i = 0; i < n; i++) {
+        arrival += next(12);
+        processes.push_back(Process("P" + to_string(i), arrival, 1 + next(10)));
+    }
+    // Xáo trộn thứ tự để bước sắp xếp trong fcfs() có chi phí thực tế
+    for (size_t i = n; i > 1; i--) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        swap(processes[i - 1], processes[(state >> 33) % i]);
+    }
+
+    using Clock = chrono::steady_clock;
+    auto elapsedMs = [](Clock::time_point from) {
+        return chrono::duration<double, milli>(Clock::now() - from).count();
+    };
+
+    bool avx2 = false;
+#ifdef HAVE_AVX2_DISPATCH
+    avx2 = cpuHasAvx2();
+#endif
+    cout << "Benchmark: " << n << " tien trinh, " << threads << " luong"
+         << (avx2 ? ", AVX2" : ", khong co AVX2 (dung ban vo huong)") << endl;
+
+    auto t0 = Clock::now();
+    vector<Process> baseline = fcfsBaseline(processes);
+    double baselineMs = elapsedMs(t0);
+
+    t0 = Clock::now();
+    vector<Process> current = fcfs(processes, threads);
+    double currentMs = elapsedMs(t0);
+
+    auto sameTimes = [](const Process& a, const Process& b) {
+        return a.id == b.id && a.start == b.start && a.finish == b.finish &&
+               a.waiting == b.waiting && a.turnaround == b.turnaround;
+    };
+    bool sameFcfs = equal(baseline.begin(), baseline.end(), current.begin(), sameTimes);
+
+    // Chỉ phần quét, trên mảng đã sắp xếp
+    for (auto& p : processes) p = Process(p.id, p.arrival, p.burst, p.priority);
+    sort(processes.begin(), processes.end(), 
+         [](const Process& a, const Process& b) { return a.arrival < b.arrival; });
+    vector<Process> sequential = processes;
+    t0 = Clock::now();
+    fcfsScanRange(sequential, 0, sequential.size(), 0);
+    double seqMs = elapsedMs(t0);
+
+    vector<Process> parallel = processes;
+    t0 = Clock::now();
+    fcfsScanParallel(parallel, threads);
+    double parMs = elapsedMs(t0);
+
+    bool sameSchedule = equal(sequential.begin(), sequential.end(), parallel.begin(), sameTimes);
+
+    t0 = Clock::now();
+    pair<double, double> baselineAverages = calculateAveragesSequential(sequential);
+    double doubleMs = elapsedMs(t0);
+
+    t0 = Clock::now();
+    pair<double, double> currentAverages = calculateAverages(sequential);
+    double averagesMs = elapsedMs(t0);
+
+    t0 = Clock::now();
+    MetricSummary scalar = summarizeMetricsScalar(sequential.data(), sequential.size());
+    double scalarMs = elapsedMs(t0);
+
+    t0 = Clock::now();
+    MetricSummary vectorized = summarizeMetrics(sequential);
+    double vectorMs = elapsedMs(t0);
+
+    bool sameMetrics = scalar.totalWaiting == vectorized.totalWaiting &&
+                       scalar.totalTurnaround == vectorized.totalTurnaround &&
+                       scalar.minWaiting == vectorized.minWaiting && scalar.maxWaiting == vectorized.maxWaiting &&
+                       scalar.minTurnaround == vectorized.minTurnaround &&
+                       scalar.maxTurnaround == vectorized.maxTurnaround;
+    bool sameAverages = baselineAverages == currentAverages;
+
+    cout << fixed << setprecision(2);
+    cout << left << setw(32) << "fcfs() goc (sort + vong lap)" << baselineMs << " ms" << endl;
+    cout << left << setw(32) << "fcfs() hien tai" << currentMs << " ms"
+         << (sameFcfs ? "  [khop]" : "  [SAI KHAC]") << endl;
+    cout << left << setw(32) << "  chi quet tuan tu" << seqMs << " ms" << endl;
+    cout << left << setw(32) << "  chi quet song song" << parMs << " ms"
+         << (sameSchedule ? "  [khop]" : "  [SAI KHAC]") << endl;
+    cout << left << setw(32) << "calculateAverages() goc" << doubleMs << " ms" << endl;
+    cout << left << setw(32) << "calculateAverages() hien tai" << averagesMs << " ms"
+         << (sameAverages ? "  [khop]" : "  [SAI KHAC]") << endl;
+    cout << left << setw(32) << "Rut gon vo huong" << scalarMs << " ms" << endl;
+    cout << left << setw(32) << "Rut gon summarizeMetrics" << vectorMs << " ms"
+         << (sameMetrics ? "  [khop]" : "  [SAI KHAC]") << endl;
+    cout << "Waiting min/max: " << vectorized.minWaiting << "/" << vectorized.maxWaiting
+         << ", Turnaround min/max: " << vectorized.minTurnaround << "/" << vectorized.maxTurnaround << endl;
+    return sameFcfs && sameSchedule && sameMetrics && sameAverages ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        return runBatchMode(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--montecarlo") {
+        return runMonteCarlo(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--server") {
+        return runServer(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        return runBenchmark(argc, argv);
+    }
+
     cout << "========================================" << endl;
     cout << "  MO PHONG THUAT TOAN LAP LICH CPU" << endl;
     cout << "========================================" << endl;
@@ -699,12 +2090,13 @@ int main() {
     cout << "\n\nBat dau mo phong..." << endl;
     
     // Chạy các thuật toán
-    vector<Process> fcfsResult = fcfs(processes);
-    vector<Process> sjfResult = sjf(processes);
-    vector<Process> priorityResult = priorityScheduling(processes);
-    vector<Process> rrResult = roundRobin(processes, quantum);
-    vector<Process> mlqResult = mlq(processes);
-    vector<Process> mlfqResult = mlfq(processes);
+    SimulationResults results = runAllAlgorithms(processes, quantum, max(1u, thread::hardware_concurrency()));
+    vector<Process>& fcfsResult = results.fcfs;
+    vector<Process>& sjfResult = results.sjf;
+    vector<Process>& priorityResult = results.priority;
+    vector<Process>& rrResult = results.rr;
+    vector<Process>& mlqResult = results.mlq;
+    vector<Process>& mlfqResult = results.mlfq;
 
     printResults("FCFS (First-Come, First-Served)", fcfsResult);
     printResults("SJF (Shortest Job First)", sjfResult);